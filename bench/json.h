@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Just enough JSON for cbt_bench to write its results and read them back as a baseline
+
+struct JsonValue
+{
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type ValueType = Type::Null;
+    bool Bool = false;
+    double Number = 0.0;
+    std::string String;
+    std::vector<JsonValue> Array;
+    std::vector<std::pair<std::string, JsonValue>> Object;
+
+    const JsonValue* Find(const char* key) const
+    {
+        for (const auto& [name, value] : Object)
+        {
+            if (name == key)
+                return &value;
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string& text)
+        : m_Text(text)
+    {
+    }
+
+    bool Parse(JsonValue& value)
+    {
+        m_Pos = 0;
+        if (!ParseValue(value))
+            return false;
+
+        SkipWhitespace();
+        return m_Pos == m_Text.size();
+    }
+
+private:
+    void SkipWhitespace()
+    {
+        while (m_Pos < m_Text.size() && (m_Text[m_Pos] == ' ' || m_Text[m_Pos] == '\t' || m_Text[m_Pos] == '\n' || m_Text[m_Pos] == '\r'))
+            m_Pos++;
+    }
+
+    bool Consume(char c)
+    {
+        SkipWhitespace();
+        if (m_Pos < m_Text.size() && m_Text[m_Pos] == c)
+        {
+            m_Pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ConsumeLiteral(const char* literal)
+    {
+        const std::string_view expected(literal);
+        if (m_Text.compare(m_Pos, expected.size(), expected) != 0)
+            return false;
+
+        m_Pos += expected.size();
+        return true;
+    }
+
+    bool ParseValue(JsonValue& value)
+    {
+        SkipWhitespace();
+        if (m_Pos >= m_Text.size())
+            return false;
+
+        switch (m_Text[m_Pos])
+        {
+        case '{': return ParseObject(value);
+        case '[': return ParseArray(value);
+        case '"': value.ValueType = JsonValue::Type::String; return ParseString(value.String);
+        case 't': value.ValueType = JsonValue::Type::Bool; value.Bool = true; return ConsumeLiteral("true");
+        case 'f': value.ValueType = JsonValue::Type::Bool; value.Bool = false; return ConsumeLiteral("false");
+        case 'n': value.ValueType = JsonValue::Type::Null; return ConsumeLiteral("null");
+        default: return ParseNumber(value);
+        }
+    }
+
+    bool ParseObject(JsonValue& value)
+    {
+        value.ValueType = JsonValue::Type::Object;
+        m_Pos++;
+        if (Consume('}'))
+            return true;
+
+        do
+        {
+            std::string key;
+            SkipWhitespace();
+            if (!ParseString(key) || !Consume(':'))
+                return false;
+
+            JsonValue member;
+            if (!ParseValue(member))
+                return false;
+            value.Object.emplace_back(std::move(key), std::move(member));
+        } while (Consume(','));
+
+        return Consume('}');
+    }
+
+    bool ParseArray(JsonValue& value)
+    {
+        value.ValueType = JsonValue::Type::Array;
+        m_Pos++;
+        if (Consume(']'))
+            return true;
+
+        do
+        {
+            JsonValue element;
+            if (!ParseValue(element))
+                return false;
+            value.Array.push_back(std::move(element));
+        } while (Consume(','));
+
+        return Consume(']');
+    }
+
+    // Escapes other than \uXXXX are supported; cbt_bench never writes those
+    bool ParseString(std::string& str)
+    {
+        if (m_Pos >= m_Text.size() || m_Text[m_Pos] != '"')
+            return false;
+        m_Pos++;
+
+        while (m_Pos < m_Text.size() && m_Text[m_Pos] != '"')
+        {
+            char c = m_Text[m_Pos++];
+            if (c == '\\')
+            {
+                if (m_Pos >= m_Text.size())
+                    return false;
+
+                switch (m_Text[m_Pos++])
+                {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u': return false;
+                default: c = m_Text[m_Pos - 1]; break;
+                }
+            }
+            str.push_back(c);
+        }
+
+        if (m_Pos >= m_Text.size())
+            return false;
+        m_Pos++;
+        return true;
+    }
+
+    bool ParseNumber(JsonValue& value)
+    {
+        const char* begin = m_Text.c_str() + m_Pos;
+        char* end = nullptr;
+        value.ValueType = JsonValue::Type::Number;
+        value.Number = std::strtod(begin, &end);
+        if (end == begin)
+            return false;
+
+        m_Pos += static_cast<size_t>(end - begin);
+        return true;
+    }
+
+    const std::string& m_Text;
+    size_t m_Pos = 0;
+};
+
+inline bool ReadJsonFile(const char* path, JsonValue& value)
+{
+    FILE* file = std::fopen(path, "rb");
+    if (!file)
+        return false;
+
+    std::string text;
+    char buffer[4096];
+    size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, count);
+    std::fclose(file);
+
+    return JsonParser(text).Parse(value);
+}
+
+inline std::string JsonEscape(const std::string& str)
+{
+    std::string escaped;
+    for (char c : str)
+    {
+        switch (c)
+        {
+        case '"': escaped += "\\\""; break;
+        case '\\': escaped += "\\\\"; break;
+        case '\n': escaped += "\\n"; break;
+        case '\t': escaped += "\\t"; break;
+        default: escaped.push_back(c); break;
+        }
+    }
+    return escaped;
+}
@@ -0,0 +1,962 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#define CBT_IMPLEMENTATION
+#include "cbt.h"
+
+#define LEB_IMPLEMENTATION
+#include "leb.h"
+
+#include "cbt_static.h"
+#include "cbt_tree.h"
+#include "leb_neighbour_table.h"
+#include "subdivision_cpu.h"
+
+#include "json.h"
+#include "perf_counter.h"
+
+// CPU microbenchmarks for the CBT / LEB primitives; these do not need Donut or a GPU
+//
+// Every benchmark runs against a tree refined with LEB splits until it holds (density * 2^maxDepth) leaves, once for
+// each max depth and density requested. Results are printed as a table and optionally written as JSON, which a later
+// run (e.g. after a libcbt / libleb upgrade) can take as its baseline to flag regressions.
+
+static const int g_JsonVersion = 2;
+
+// Set by bench/CMakeLists.txt, and written to the JSON config so that a baseline from another build is not compared
+#ifndef CBT_BENCH_BUILD_TYPE
+#define CBT_BENCH_BUILD_TYPE "unknown"
+#endif
+#ifndef CBT_BENCH_COMPILER
+#define CBT_BENCH_COMPILER "unknown"
+#endif
+
+// Target position used by the IsInside and cbt_Update benchmarks
+static const float g_Target[2] = { 0.2371f, 0.7104f };
+
+struct BenchOptions
+{
+    int64_t MinDepth = 6;
+    int64_t MaxDepth = 24;
+    int64_t DepthStep = 2;
+    std::vector<double> Densities = { 0.01, 0.1 };
+    int64_t OpCount = 1 << 16;
+    int Repeats = 5;
+    uint32_t Seed = 1;
+    std::string Filter;
+    std::string JsonPath;
+    std::string BaselinePath;
+    double Tolerance = 0.1;
+};
+
+struct BenchResult
+{
+    std::string Name;
+    int64_t MaxDepth = 0;
+    double Density = 0.0;
+    int64_t LeafCount = 0;
+    int64_t OpCount = 0;
+    double NsPerOp = 0.0;           // Median over repeats
+    double MinNsPerOp = 0.0;
+    double CacheMissesPerOp = -1.0; // Median over repeats, negative if unavailable
+};
+
+struct MemoryResult
+{
+    int64_t MaxDepth = 0;
+    double Density = 0.0;
+    int64_t LeafCount = 0;
+    int64_t HeapByteSize = 0;
+    int64_t NeighbourTableByteSize = 0;
+};
+
+// Results are accumulated here so the measured loops cannot be optimized away
+static volatile uint64_t g_Sink = 0;
+
+struct FaceVertices
+{
+    float Vertices[2][3];
+};
+
+// State shared by every benchmark at one (depth, density)
+struct BenchContext
+{
+    int64_t MaxDepth = 0;
+    double Density = 0.0;
+    cbt_Tree* Tree = nullptr;
+    std::vector<char> Heap; // Refined state, restored before each run of a benchmark that modifies the tree
+
+    // One entry per operation
+    std::vector<int64_t> Handles;
+    std::vector<cbt_Node> Leaves; // Decoded from Handles
+    std::vector<leb_DiamondParent> Diamonds;
+    std::vector<FaceVertices> Faces;
+    std::vector<cbt_Node> Nodes;  // Random nodes at every depth, for the raw heap accesses
+    std::vector<uint64_t> NodeValues;
+
+    LebNeighbourTable NeighbourTable; // Built from Heap
+
+    BenchContext() = default;
+    BenchContext(const BenchContext&) = delete;
+    BenchContext& operator=(const BenchContext&) = delete;
+    ~BenchContext() { if (Tree) cbt_Release(Tree); }
+
+    void RestoreHeap() const { cbt_SetHeap(Tree, Heap.data()); }
+    void RestoreNeighbourTable() { RestoreHeap(); NeighbourTable.Build(Tree); }
+};
+
+struct BenchCase
+{
+    std::string Name;
+    std::function<void()> Prepare; // Untimed, runs before every repeat
+    std::function<int64_t()> Run;  // Returns the number of operations performed
+};
+
+struct RefineData
+{
+    std::mt19937* Rng;
+    double Probability;
+};
+
+void RefineCallback(cbt_Tree* cbt, const cbt_Node node, const void* userData)
+{
+    const RefineData* data = static_cast<const RefineData*>(userData);
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(*data->Rng) < data->Probability)
+        leb_SplitNode_Square(cbt, node);
+}
+
+// Splits random leaves one cbt_Update at a time, so that the tree stays a conforming LEB mesh
+void RefineToDensity(cbt_Tree* tree, double density, std::mt19937& rng)
+{
+    const int64_t targetCount = std::max<int64_t>(2, static_cast<int64_t>(density * static_cast<double>(1ll << cbt_MaxDepth(tree))));
+
+    for (int pass = 0; pass < 64; pass++)
+    {
+        const int64_t nodeCount = cbt_NodeCount(tree);
+        if (nodeCount >= targetCount)
+            break;
+
+        RefineData data = { &rng, std::min(1.0, static_cast<double>(targetCount - nodeCount) / static_cast<double>(nodeCount)) };
+        cbt_Update(tree, &RefineCallback, &data);
+
+        if (cbt_NodeCount(tree) == nodeCount && data.Probability >= 1.0)
+            break;
+    }
+}
+
+void CreateContext(BenchContext& ctx, int64_t maxDepth, double density, const BenchOptions& options)
+{
+    std::mt19937 rng(options.Seed);
+
+    ctx.MaxDepth = maxDepth;
+    ctx.Density = density;
+    ctx.Tree = cbt_CreateAtDepth(maxDepth, 1);
+    RefineToDensity(ctx.Tree, density, rng);
+
+    const char* heap = cbt_GetHeap(ctx.Tree);
+    ctx.Heap.assign(heap, heap + cbt_HeapByteSize(ctx.Tree));
+
+    std::uniform_int_distribution<int64_t> handleDistribution(0, cbt_NodeCount(ctx.Tree) - 1);
+    std::uniform_int_distribution<int64_t> depthDistribution(0, maxDepth);
+
+    for (int64_t i = 0; i < options.OpCount; i++)
+    {
+        const int64_t handle = handleDistribution(rng);
+        const cbt_Node leaf = cbt_DecodeNode(ctx.Tree, handle);
+
+        FaceVertices face = { {
+            {0.0f, 0.0f, 1.0f},
+            {1.0f, 0.0f, 0.0f}
+        } };
+        leb_DecodeNodeAttributeArray_Square(leaf, 2, face.Vertices);
+
+        ctx.Handles.push_back(handle);
+        ctx.Leaves.push_back(leaf);
+        ctx.Diamonds.push_back(leb_DecodeDiamondParent_Square(leaf));
+        ctx.Faces.push_back(face);
+
+        const int64_t depth = depthDistribution(rng);
+        const uint64_t id = std::uniform_int_distribution<uint64_t>(1ull << depth, (2ull << depth) - 1u)(rng);
+        ctx.Nodes.push_back(cbt_CreateNode(id, depth));
+        ctx.NodeValues.push_back(cbt_HeapRead(ctx.Tree, ctx.Nodes.back()));
+    }
+
+    ctx.NeighbourTable.Build(ctx.Tree);
+}
+
+void AddLibraryCases(std::vector<BenchCase>& cases, BenchContext& ctx)
+{
+    const auto restore = [&ctx] { ctx.RestoreHeap(); };
+    const auto opCount = static_cast<int64_t>(ctx.Handles.size());
+
+    cases.push_back({ "cbt_HeapRead", nullptr, [&ctx, opCount]
+    {
+        uint64_t sum = 0;
+        for (const cbt_Node& node : ctx.Nodes)
+            sum += cbt_HeapRead(ctx.Tree, node);
+        g_Sink = g_Sink + sum;
+        return opCount;
+    } });
+
+    // libcbt keeps its heap write internal; the values written back are the ones already stored
+    cases.push_back({ "cbt_HeapWrite", nullptr, [&ctx, opCount]
+    {
+        for (size_t i = 0; i < ctx.Nodes.size(); i++)
+            cbt__HeapWrite(ctx.Tree, ctx.Nodes[i], ctx.NodeValues[i]);
+        return opCount;
+    } });
+
+    cases.push_back({ "cbt_NodeCount", nullptr, [&ctx, opCount]
+    {
+        uint64_t sum = 0;
+        for (int64_t i = 0; i < opCount; i++)
+            sum += static_cast<uint64_t>(cbt_NodeCount(ctx.Tree));
+        g_Sink = g_Sink + sum;
+        return opCount;
+    } });
+
+    cases.push_back({ "cbt_DecodeNode", nullptr, [&ctx, opCount]
+    {
+        uint64_t sum = 0;
+        for (int64_t handle : ctx.Handles)
+            sum += cbt_DecodeNode(ctx.Tree, handle).id;
+        g_Sink = g_Sink + sum;
+        return opCount;
+    } });
+
+    cases.push_back({ "cbt_EncodeNode", nullptr, [&ctx, opCount]
+    {
+        uint64_t sum = 0;
+        for (const cbt_Node& leaf : ctx.Leaves)
+            sum += static_cast<uint64_t>(cbt_EncodeNode(ctx.Tree, leaf));
+        g_Sink = g_Sink + sum;
+        return opCount;
+    } });
+
+    cases.push_back({ "cbt_ComputeSumReduction", nullptr, [&ctx]
+    {
+        cbt_ComputeSumReduction(ctx.Tree);
+        return int64_t(1);
+    } });
+
+    cases.push_back({ "leb_DecodeNodeAttributeArray_Square", nullptr, [&ctx, opCount]
+    {
+        float sum = 0.0f;
+        for (const cbt_Node& leaf : ctx.Leaves)
+        {
+            float faceVertices[][3] = {
+                {0.0f, 0.0f, 1.0f},
+                {1.0f, 0.0f, 0.0f}
+            };
+            leb_DecodeNodeAttributeArray_Square(leaf, 2, faceVertices);
+            sum += faceVertices[0][0];
+        }
+        g_Sink = g_Sink + static_cast<uint64_t>(sum);
+        return opCount;
+    } });
+
+    cases.push_back({ "leb_DecodeDiamondParent_Square", nullptr, [&ctx, opCount]
+    {
+        uint64_t sum = 0;
+        for (const cbt_Node& leaf : ctx.Leaves)
+            sum += leb_DecodeDiamondParent_Square(leaf).top.id;
+        g_Sink = g_Sink + sum;
+        return opCount;
+    } });
+
+    cases.push_back({ "IsInside", nullptr, [&ctx, opCount]
+    {
+        uint64_t count = 0;
+        for (const FaceVertices& face : ctx.Faces)
+            count += IsInside(face.Vertices, g_Target) ? 1u : 0u;
+        g_Sink = g_Sink + count;
+        return opCount;
+    } });
+
+    // Plain CBT splits and merges of the same leaves, as CbtTree's SplitNode and MergeNode measure
+    cases.push_back({ "cbt_SplitNode", restore, [&ctx, opCount]
+    {
+        for (const cbt_Node& leaf : ctx.Leaves)
+            cbt_SplitNode(ctx.Tree, leaf);
+        return opCount;
+    } });
+
+    cases.push_back({ "cbt_MergeNode", restore, [&ctx, opCount]
+    {
+        for (const cbt_Node& leaf : ctx.Leaves)
+            cbt_MergeNode(ctx.Tree, leaf);
+        return opCount;
+    } });
+
+    cases.push_back({ "leb_SplitNode_Square", restore, [&ctx, opCount]
+    {
+        for (const cbt_Node& leaf : ctx.Leaves)
+            leb_SplitNode_Square(ctx.Tree, leaf);
+        return opCount;
+    } });
+
+    cases.push_back({ "leb_MergeNode_Square", restore, [&ctx, opCount]
+    {
+        for (size_t i = 0; i < ctx.Leaves.size(); i++)
+            leb_MergeNode_Square(ctx.Tree, ctx.Leaves[i], ctx.Diamonds[i]);
+        return opCount;
+    } });
+
+    // One frame of the sample's CPU backend each
+    cases.push_back({ "cbt_Update/Split", restore, [&ctx]
+    {
+        cbt_Update(ctx.Tree, &UpdateSubdivisionCpuCallback_Split, g_Target);
+        return int64_t(1);
+    } });
+
+    cases.push_back({ "cbt_Update/Merge", restore, [&ctx]
+    {
+        cbt_Update(ctx.Tree, &UpdateSubdivisionCpuCallback_Merge, g_Target);
+        return int64_t(1);
+    } });
+}
+
+// The CPU trees of source/ (see cbt_tree.h and cbt_static.h), loaded with the same leaves as libcbt
+// Returns false if the tree does not round trip libcbt's heap
+template <typename Tree>
+bool AddTreeCases(std::vector<BenchCase>& cases, BenchContext& ctx, const std::string& prefix, std::shared_ptr<Tree> tree)
+{
+    tree->SetLevelMajorHeap(ctx.Heap.data());
+
+    std::vector<char> heap(ctx.Heap.size());
+    tree->WriteLevelMajorHeap(heap.data());
+    if (heap != ctx.Heap)
+    {
+        std::fprintf(stderr, "%s does not match libcbt at depth %lld\n", prefix.c_str(), static_cast<long long>(ctx.MaxDepth));
+        return false;
+    }
+
+    const auto restore = [&ctx, tree] { tree->SetLevelMajorHeap(ctx.Heap.data()); };
+    const auto opCount = static_cast<int64_t>(ctx.Handles.size());
+
+    cases.push_back({ prefix + "/DecodeNode", nullptr, [&ctx, tree, opCount]
+    {
+        uint64_t sum = 0;
+        for (int64_t handle : ctx.Handles)
+            sum += tree->DecodeNode(handle).id;
+        g_Sink = g_Sink + sum;
+        return opCount;
+    } });
+
+    cases.push_back({ prefix + "/EncodeNode", nullptr, [&ctx, tree, opCount]
+    {
+        uint64_t sum = 0;
+        for (const cbt_Node& leaf : ctx.Leaves)
+            sum += static_cast<uint64_t>(tree->EncodeNode(leaf));
+        g_Sink = g_Sink + sum;
+        return opCount;
+    } });
+
+    cases.push_back({ prefix + "/SplitNode", restore, [&ctx, tree, opCount]
+    {
+        for (const cbt_Node& leaf : ctx.Leaves)
+            tree->SplitNode(leaf);
+        return opCount;
+    } });
+
+    cases.push_back({ prefix + "/MergeNode", restore, [&ctx, tree, opCount]
+    {
+        for (const cbt_Node& leaf : ctx.Leaves)
+            tree->MergeNode(leaf);
+        return opCount;
+    } });
+
+    cases.push_back({ prefix + "/ComputeSumReduction", nullptr, [tree]
+    {
+        tree->ComputeSumReduction();
+        return int64_t(1);
+    } });
+
+    return true;
+}
+
+// Checks that the table's current leaves and diamond parents agree with libcbt / libleb, sampled at random handles
+bool CheckNeighbourTable(BenchContext& ctx, const char* operation)
+{
+    cbt_ComputeSumReduction(ctx.Tree);
+    bool valid = static_cast<int64_t>(ctx.NeighbourTable.LeafCount()) == cbt_NodeCount(ctx.Tree);
+
+    std::mt19937 rng(ctx.Handles.size());
+    std::uniform_int_distribution<int64_t> handleDistribution(0, cbt_NodeCount(ctx.Tree) - 1);
+    for (size_t i = 0; i < ctx.Handles.size() && valid; i++)
+    {
+        const cbt_Node leaf = cbt_DecodeNode(ctx.Tree, handleDistribution(rng));
+        const leb_DiamondParent expected = leb_DecodeDiamondParent_Square(leaf);
+        const leb_DiamondParent diamond = ctx.NeighbourTable.DecodeDiamondParent(leaf);
+
+        valid = ctx.NeighbourTable.IsLeaf(leaf.id) && diamond.base.id == expected.base.id && diamond.top.id == expected.top.id;
+    }
+
+    if (!valid)
+        std::fprintf(stderr, "LebNeighbourTable does not match libleb after %s at depth %lld\n", operation, static_cast<long long>(ctx.MaxDepth));
+    return valid;
+}
+
+// Runs the same splits and merges through libleb and the table, which must leave identical heaps
+bool VerifyNeighbourTable(BenchContext& ctx)
+{
+    const auto run = [&ctx](const char* operation, const std::function<void()>& libleb, const std::function<void()>& table)
+    {
+        ctx.RestoreHeap();
+        libleb();
+        const std::vector<char> expected(cbt_GetHeap(ctx.Tree), cbt_GetHeap(ctx.Tree) + ctx.Heap.size());
+
+        ctx.RestoreNeighbourTable();
+        table();
+        if (std::memcmp(expected.data(), cbt_GetHeap(ctx.Tree), expected.size()))
+        {
+            std::fprintf(stderr, "LebNeighbourTable %s does not match libleb at depth %lld\n", operation, static_cast<long long>(ctx.MaxDepth));
+            return false;
+        }
+        return CheckNeighbourTable(ctx, operation);
+    };
+
+    const bool valid = run("splits",
+        [&ctx] { for (const cbt_Node& leaf : ctx.Leaves) leb_SplitNode_Square(ctx.Tree, leaf); },
+        [&ctx] { for (const cbt_Node& leaf : ctx.Leaves) ctx.NeighbourTable.SplitNode(ctx.Tree, leaf); })
+        && run("merges",
+        [&ctx] { for (const cbt_Node& leaf : ctx.Leaves) leb_MergeNode_Square(ctx.Tree, leaf, leb_DecodeDiamondParent_Square(leaf)); },
+        [&ctx] { for (const cbt_Node& leaf : ctx.Leaves) ctx.NeighbourTable.MergeNode(ctx.Tree, leaf, ctx.NeighbourTable.DecodeDiamondParent(leaf)); });
+
+    ctx.RestoreNeighbourTable();
+    return valid;
+}
+
+// The same operations as leb_*_Square and the CPU backend's callbacks, going through a LebNeighbourTable
+void AddNeighbourTableCases(std::vector<BenchCase>& cases, BenchContext& ctx)
+{
+    const auto restore = [&ctx] { ctx.RestoreNeighbourTable(); };
+    const auto opCount = static_cast<int64_t>(ctx.Handles.size());
+
+    cases.push_back({ "LebNeighbourTable/Build", nullptr, [&ctx]
+    {
+        ctx.NeighbourTable.Build(ctx.Tree);
+        return int64_t(1);
+    } });
+
+    cases.push_back({ "LebNeighbourTable/DecodeDiamondParent", nullptr, [&ctx, opCount]
+    {
+        uint64_t sum = 0;
+        for (const cbt_Node& leaf : ctx.Leaves)
+            sum += ctx.NeighbourTable.DecodeDiamondParent(leaf).top.id;
+        g_Sink = g_Sink + sum;
+        return opCount;
+    } });
+
+    cases.push_back({ "LebNeighbourTable/SplitNode", restore, [&ctx, opCount]
+    {
+        for (const cbt_Node& leaf : ctx.Leaves)
+            ctx.NeighbourTable.SplitNode(ctx.Tree, leaf);
+        return opCount;
+    } });
+
+    cases.push_back({ "LebNeighbourTable/MergeNode", restore, [&ctx, opCount]
+    {
+        for (size_t i = 0; i < ctx.Leaves.size(); i++)
+            ctx.NeighbourTable.MergeNode(ctx.Tree, ctx.Leaves[i], ctx.Diamonds[i]);
+        return opCount;
+    } });
+
+    cases.push_back({ "LebNeighbourTable/cbt_Update/Split", restore, [&ctx]
+    {
+        const SubdivisionCpuTableData data = { g_Target, &ctx.NeighbourTable };
+        cbt_Update(ctx.Tree, &UpdateSubdivisionCpuTableCallback_Split, &data);
+        return int64_t(1);
+    } });
+
+    cases.push_back({ "LebNeighbourTable/cbt_Update/Merge", restore, [&ctx]
+    {
+        const SubdivisionCpuTableData data = { g_Target, &ctx.NeighbourTable };
+        cbt_Update(ctx.Tree, &UpdateSubdivisionCpuTableCallback_Merge, &data);
+        return int64_t(1);
+    } });
+}
+
+bool CreateCases(BenchContext& ctx, std::vector<BenchCase>& cases)
+{
+    AddLibraryCases(cases, ctx);
+
+    if (!VerifyNeighbourTable(ctx))
+        return false;
+    AddNeighbourTableCases(cases, ctx);
+
+    using BlockedFromLeaves = CbtBlockedLayout<CbtRowSplit::FromLeaves>;
+    using BlockedFromRoot = CbtBlockedLayout<CbtRowSplit::FromRoot>;
+
+    bool valid = AddTreeCases(cases, ctx, "CbtTree<LevelMajor>", std::make_shared<CbtTree<CbtLevelMajorLayout>>(ctx.MaxDepth, 0))
+        && AddTreeCases(cases, ctx, "CbtTree<BlockedFromLeaves>", std::make_shared<CbtTree<BlockedFromLeaves>>(ctx.MaxDepth, 0))
+        && AddTreeCases(cases, ctx, "CbtTree<BlockedFromRoot>", std::make_shared<CbtTree<BlockedFromRoot>>(ctx.MaxDepth, 0));
+
+    CbtDispatchMaxDepth(ctx.MaxDepth, [&](auto maxDepth)
+    {
+        valid = valid
+            && AddTreeCases(cases, ctx, "Cbt<LevelMajor>", std::make_shared<Cbt<maxDepth, CbtLevelMajorLayout>>(0))
+            && AddTreeCases(cases, ctx, "Cbt<BlockedFromLeaves>", std::make_shared<Cbt<maxDepth, BlockedFromLeaves>>(0))
+            && AddTreeCases(cases, ctx, "Cbt<BlockedFromRoot>", std::make_shared<Cbt<maxDepth, BlockedFromRoot>>(0));
+    });
+
+    return valid;
+}
+
+double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+BenchResult RunCase(const BenchCase& bench, const BenchContext& ctx, const BenchOptions& options, const CacheMissCounter& counter)
+{
+    std::vector<double> nsPerOp;
+    std::vector<double> cacheMissesPerOp;
+    int64_t opCount = 0;
+
+    for (int repeat = 0; repeat < options.Repeats; repeat++)
+    {
+        if (bench.Prepare)
+            bench.Prepare();
+
+        counter.Start();
+        const auto start = std::chrono::steady_clock::now();
+        opCount = bench.Run();
+        const auto end = std::chrono::steady_clock::now();
+        const int64_t cacheMisses = counter.Stop();
+
+        nsPerOp.push_back(std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(opCount));
+        if (cacheMisses >= 0)
+            cacheMissesPerOp.push_back(static_cast<double>(cacheMisses) / static_cast<double>(opCount));
+    }
+
+    // Leave the tree as it was found for the next benchmark
+    if (bench.Prepare)
+        bench.Prepare();
+
+    BenchResult result;
+    result.Name = bench.Name;
+    result.MaxDepth = ctx.MaxDepth;
+    result.Density = ctx.Density;
+    result.LeafCount = cbt_NodeCount(ctx.Tree);
+    result.OpCount = opCount;
+    result.NsPerOp = Median(nsPerOp);
+    result.MinNsPerOp = *std::min_element(nsPerOp.begin(), nsPerOp.end());
+    if (!cacheMissesPerOp.empty())
+        result.CacheMissesPerOp = Median(cacheMissesPerOp);
+    return result;
+}
+
+// Width of the benchmark column of the printed tables
+template <typename T, typename GetName>
+int NameColumnWidth(const std::vector<T>& items, GetName&& getName)
+{
+    size_t width = std::strlen("benchmark");
+    for (const T& item : items)
+        width = std::max(width, getName(item).size());
+    return static_cast<int>(width);
+}
+
+std::string ResultKey(const std::string& name, int64_t maxDepth, double density)
+{
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "|%lld|%g", static_cast<long long>(maxDepth), density);
+    return name + buffer;
+}
+
+bool WriteJson(const std::string& path, const BenchOptions& options, const std::vector<BenchResult>& results,
+               const std::vector<MemoryResult>& memory)
+{
+    FILE* file = path == "-" ? stdout : std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"version\": %d,\n", g_JsonVersion);
+    std::fprintf(file, "  \"config\": { \"build_type\": \"%s\", \"compiler\": \"%s\", \"min_depth\": %lld, \"max_depth\": %lld, "
+        "\"depth_step\": %lld, \"densities\": [",
+        JsonEscape(CBT_BENCH_BUILD_TYPE).c_str(), JsonEscape(CBT_BENCH_COMPILER).c_str(),
+        static_cast<long long>(options.MinDepth), static_cast<long long>(options.MaxDepth), static_cast<long long>(options.DepthStep));
+    for (size_t i = 0; i < options.Densities.size(); i++)
+        std::fprintf(file, "%s%.17g", i > 0 ? ", " : "", options.Densities[i]);
+    std::fprintf(file, "], \"filter\": \"%s\", \"ops\": %lld, \"repeats\": %d, \"seed\": %u },\n",
+        JsonEscape(options.Filter).c_str(), static_cast<long long>(options.OpCount), options.Repeats, options.Seed);
+    std::fprintf(file, "  \"results\": [\n");
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& result = results[i];
+        std::fprintf(file, "    { \"name\": \"%s\", \"max_depth\": %lld, \"density\": %g, \"leaf_count\": %lld, \"ops\": %lld, "
+            "\"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"cache_misses_per_op\": ",
+            JsonEscape(result.Name).c_str(), static_cast<long long>(result.MaxDepth), result.Density,
+            static_cast<long long>(result.LeafCount), static_cast<long long>(result.OpCount),
+            result.NsPerOp, result.MinNsPerOp);
+
+        if (result.CacheMissesPerOp < 0.0)
+            std::fprintf(file, "null");
+        else
+            std::fprintf(file, "%.4f", result.CacheMissesPerOp);
+
+        std::fprintf(file, " }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    std::fprintf(file, "  ],\n");
+    std::fprintf(file, "  \"memory\": [\n");
+
+    for (size_t i = 0; i < memory.size(); i++)
+    {
+        const MemoryResult& result = memory[i];
+        std::fprintf(file, "    { \"max_depth\": %lld, \"density\": %g, \"leaf_count\": %lld, \"cbt_heap_bytes\": %lld, "
+            "\"neighbour_table_bytes\": %lld }%s\n",
+            static_cast<long long>(result.MaxDepth), result.Density, static_cast<long long>(result.LeafCount),
+            static_cast<long long>(result.HeapByteSize), static_cast<long long>(result.NeighbourTableByteSize),
+            i + 1 < memory.size() ? "," : "");
+    }
+
+    std::fprintf(file, "  ]\n}\n");
+
+    if (file != stdout)
+        std::fclose(file);
+    return true;
+}
+
+// Timings are only comparable between runs of the same build with the same workload
+bool MatchesBaselineConfig(const std::string& path, const JsonValue* config, const BenchOptions& options)
+{
+    const auto matchString = [&](const char* key, const char* expected)
+    {
+        const JsonValue* value = config ? config->Find(key) : nullptr;
+        if (value && value->ValueType == JsonValue::Type::String && value->String == expected)
+            return true;
+
+        std::fprintf(stderr, "Baseline %s has %s \"%s\", this run has \"%s\"\n",
+            path.c_str(), key, value ? value->String.c_str() : "", expected);
+        return false;
+    };
+    const auto matchNumber = [&](const char* key, double expected)
+    {
+        const JsonValue* value = config ? config->Find(key) : nullptr;
+        if (value && value->ValueType == JsonValue::Type::Number && value->Number == expected)
+            return true;
+
+        std::fprintf(stderr, "Baseline %s has %s %g, this run has %g\n", path.c_str(), key, value ? value->Number : 0.0, expected);
+        return false;
+    };
+
+    const auto matchDensities = [&]
+    {
+        const JsonValue* value = config ? config->Find("densities") : nullptr;
+        bool equal = value && value->ValueType == JsonValue::Type::Array && value->Array.size() == options.Densities.size();
+        for (size_t i = 0; equal && i < options.Densities.size(); i++)
+            equal = value->Array[i].ValueType == JsonValue::Type::Number && value->Array[i].Number == options.Densities[i];
+
+        if (!equal)
+            std::fprintf(stderr, "Baseline %s was run with different densities\n", path.c_str());
+        return equal;
+    };
+
+    // Every mismatch is reported before refusing the baseline
+    bool matches = matchString("build_type", CBT_BENCH_BUILD_TYPE);
+    matches = matchString("compiler", CBT_BENCH_COMPILER) && matches;
+    matches = matchNumber("min_depth", static_cast<double>(options.MinDepth)) && matches;
+    matches = matchNumber("max_depth", static_cast<double>(options.MaxDepth)) && matches;
+    matches = matchNumber("depth_step", static_cast<double>(options.DepthStep)) && matches;
+    matches = matchDensities() && matches;
+    matches = matchString("filter", options.Filter.c_str()) && matches;
+    matches = matchNumber("ops", static_cast<double>(options.OpCount)) && matches;
+    matches = matchNumber("repeats", options.Repeats) && matches;
+    matches = matchNumber("seed", options.Seed) && matches;
+    return matches;
+}
+
+// Reads the median ns/op of a previous --json output, keyed by ResultKey
+// Fails if the file cannot be read or was produced by a different build or configuration
+bool ReadBaseline(const std::string& path, const BenchOptions& options, std::map<std::string, double>& baselineNsPerOp)
+{
+    JsonValue baseline;
+    if (!ReadJsonFile(path.c_str(), baseline) || baseline.ValueType != JsonValue::Type::Object)
+    {
+        std::fprintf(stderr, "Failed to read baseline %s\n", path.c_str());
+        return false;
+    }
+
+    const JsonValue* version = baseline.Find("version");
+    const JsonValue* baselineResults = baseline.Find("results");
+    if (!version || version->Number != g_JsonVersion || !baselineResults || baselineResults->ValueType != JsonValue::Type::Array)
+    {
+        std::fprintf(stderr, "Baseline %s is not a version %d cbt_bench result file\n", path.c_str(), g_JsonVersion);
+        return false;
+    }
+
+    if (!MatchesBaselineConfig(path, baseline.Find("config"), options))
+        return false;
+
+    for (const JsonValue& entry : baselineResults->Array)
+    {
+        const JsonValue* name = entry.Find("name");
+        const JsonValue* maxDepth = entry.Find("max_depth");
+        const JsonValue* density = entry.Find("density");
+        const JsonValue* nsPerOp = entry.Find("ns_per_op");
+        if (name && maxDepth && density && nsPerOp)
+            baselineNsPerOp[ResultKey(name->String, static_cast<int64_t>(maxDepth->Number), density->Number)] = nsPerOp->Number;
+    }
+    return true;
+}
+
+// Compares median ns/op against the baseline
+// Returns false on any regression, on baseline entries without a result in this run, or if nothing was compared
+bool CompareWithBaseline(const std::string& path, double tolerance, const std::map<std::string, double>& baselineNsPerOp,
+                         const std::vector<BenchResult>& results)
+{
+    int regressions = 0;
+    int compared = 0;
+    std::set<std::string> resultKeys;
+
+    std::fprintf(stderr, "\nComparison with %s (tolerance %.0f%%)\n", path.c_str(), tolerance * 100.0);
+    const int nameWidth = NameColumnWidth(results, [](const BenchResult& result) { return result.Name; });
+    std::fprintf(stderr, "%-*s %5s %8s %14s %14s %9s\n", nameWidth, "benchmark", "depth", "density", "baseline ns/op", "ns/op", "change");
+
+    for (const BenchResult& result : results)
+    {
+        const std::string key = ResultKey(result.Name, result.MaxDepth, result.Density);
+        resultKeys.insert(key);
+
+        const auto it = baselineNsPerOp.find(key);
+        if (it == baselineNsPerOp.end())
+            continue;
+
+        const double change = result.NsPerOp / it->second - 1.0;
+        const bool isRegression = change > tolerance;
+        regressions += isRegression ? 1 : 0;
+        compared++;
+
+        std::fprintf(stderr, "%-*s %5lld %8g %14.2f %14.2f %+8.1f%%%s\n",
+            nameWidth, result.Name.c_str(), static_cast<long long>(result.MaxDepth), result.Density,
+            it->second, result.NsPerOp, change * 100.0, isRegression ? "  REGRESSION" : "");
+    }
+
+    int missing = 0;
+    for (const auto& [key, nsPerOp] : baselineNsPerOp)
+    {
+        if (!resultKeys.contains(key))
+        {
+            std::fprintf(stderr, "Baseline entry %s has no result in this run\n", key.c_str());
+            missing++;
+        }
+    }
+
+    std::fprintf(stderr, "%d of %d benchmarks regressed, %d had no baseline entry, %d baseline entries were not run\n",
+        regressions, compared, static_cast<int>(results.size()) - compared, missing);
+    if (compared == 0)
+        std::fprintf(stderr, "No benchmarks were compared with the baseline\n");
+
+    return regressions == 0 && missing == 0 && compared > 0;
+}
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: cbt_bench [options]\n"
+        "  --min-depth <n>       Smallest max depth (default 6)\n"
+        "  --max-depth <n>       Largest max depth (default 24)\n"
+        "  --depth-step <n>      Step between max depths (default 2)\n"
+        "  --densities <f,...>   Leaf counts as fractions of 2^maxDepth (default 0.01,0.1)\n"
+        "  --ops <n>             Operations per measurement (default 65536)\n"
+        "  --repeats <n>         Measurements per benchmark, the median is reported (default 5)\n"
+        "  --seed <n>            Random seed (default 1)\n"
+        "  --filter <str>        Only run benchmarks whose name contains str\n"
+        "  --json <path>         Write the results as JSON ('-' for stdout)\n"
+        "  --baseline <path>     Compare with a previous --json output, exiting with 2 on regressions\n"
+        "                        or if any baseline benchmark was not run\n"
+        "  --tolerance <f>       Slowdown allowed before a benchmark counts as regressed (default 0.1)\n");
+}
+
+bool ParseDensities(const char* value, std::vector<double>& densities)
+{
+    densities.clear();
+    for (const char* it = value; *it;)
+    {
+        char* end = nullptr;
+        densities.push_back(std::strtod(it, &end));
+        if (end == it || (*end && *end != ','))
+            return false;
+        it = *end ? end + 1 : end;
+    }
+    return !densities.empty();
+}
+
+bool ParseOptions(int argc, const char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--help"))
+            return false;
+        if (!value)
+        {
+            std::fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        }
+
+        if (!std::strcmp(arg, "--min-depth"))
+            options.MinDepth = std::atoll(value);
+        else if (!std::strcmp(arg, "--max-depth"))
+            options.MaxDepth = std::atoll(value);
+        else if (!std::strcmp(arg, "--depth-step"))
+            options.DepthStep = std::atoll(value);
+        else if (!std::strcmp(arg, "--densities"))
+        {
+            if (!ParseDensities(value, options.Densities))
+            {
+                std::fprintf(stderr, "Invalid density list %s\n", value);
+                return false;
+            }
+        }
+        else if (!std::strcmp(arg, "--ops"))
+            options.OpCount = std::atoll(value);
+        else if (!std::strcmp(arg, "--repeats"))
+            options.Repeats = std::atoi(value);
+        else if (!std::strcmp(arg, "--seed"))
+            options.Seed = static_cast<uint32_t>(std::atoll(value));
+        else if (!std::strcmp(arg, "--filter"))
+            options.Filter = value;
+        else if (!std::strcmp(arg, "--json"))
+            options.JsonPath = value;
+        else if (!std::strcmp(arg, "--baseline"))
+            options.BaselinePath = value;
+        else if (!std::strcmp(arg, "--tolerance"))
+            options.Tolerance = std::atof(value);
+        else
+        {
+            std::fprintf(stderr, "Unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+
+    if (options.MinDepth < g_CbtMinStaticDepth || options.MaxDepth > g_CbtMaxStaticDepth || options.MinDepth > options.MaxDepth)
+    {
+        std::fprintf(stderr, "Depths must satisfy %lld <= min-depth <= max-depth <= %lld\n",
+            static_cast<long long>(g_CbtMinStaticDepth), static_cast<long long>(g_CbtMaxStaticDepth));
+        return false;
+    }
+    if (options.DepthStep < 1 || options.OpCount < 1 || options.Repeats < 1)
+    {
+        std::fprintf(stderr, "depth-step, ops and repeats must be positive\n");
+        return false;
+    }
+    for (double density : options.Densities)
+    {
+        if (density <= 0.0 || density > 1.0)
+        {
+            std::fprintf(stderr, "Densities must be in (0, 1]\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, const char** argv)
+{
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // The table moves to stderr when stdout carries the JSON
+    FILE* table = options.JsonPath == "-" ? stderr : stdout;
+
+    // Checked up front, so that a mismatched baseline does not cost a full run
+    std::map<std::string, double> baselineNsPerOp;
+    if (!options.BaselinePath.empty() && !ReadBaseline(options.BaselinePath, options, baselineNsPerOp))
+        return 1;
+
+    CacheMissCounter counter;
+    if (!counter.IsAvailable())
+        std::fprintf(table, "Cache miss counters unavailable, reporting timings only\n");
+
+    std::fprintf(table, "Build type %s, compiler %s\n", CBT_BENCH_BUILD_TYPE, CBT_BENCH_COMPILER);
+    std::vector<BenchResult> results;
+    std::vector<MemoryResult> memory;
+    int nameWidth = 0;
+    for (int64_t maxDepth = options.MinDepth; maxDepth <= options.MaxDepth; maxDepth += options.DepthStep)
+    {
+        for (double density : options.Densities)
+        {
+            BenchContext ctx;
+            CreateContext(ctx, maxDepth, density, options);
+
+            std::vector<BenchCase> cases;
+            if (!CreateCases(ctx, cases))
+                return 1;
+
+            // Every context has the same cases, so the header is printed once their names are known
+            if (nameWidth == 0)
+            {
+                nameWidth = NameColumnWidth(cases, [](const BenchCase& bench) { return bench.Name; });
+                std::fprintf(table, "%-*s %5s %8s %10s %12s %12s %12s\n",
+                    nameWidth, "benchmark", "depth", "density", "leaves", "ns/op", "min ns/op", "misses/op");
+            }
+
+            MemoryResult& memoryResult = memory.emplace_back();
+            memoryResult.MaxDepth = maxDepth;
+            memoryResult.Density = density;
+            memoryResult.LeafCount = cbt_NodeCount(ctx.Tree);
+            memoryResult.HeapByteSize = cbt_HeapByteSize(ctx.Tree);
+            memoryResult.NeighbourTableByteSize = static_cast<int64_t>(ctx.NeighbourTable.ByteSize());
+
+            for (const BenchCase& bench : cases)
+            {
+                if (!options.Filter.empty() && bench.Name.find(options.Filter) == std::string::npos)
+                    continue;
+
+                const BenchResult& result = results.emplace_back(RunCase(bench, ctx, options, counter));
+
+                char cacheMisses[32] = "n/a";
+                if (result.CacheMissesPerOp >= 0.0)
+                    std::snprintf(cacheMisses, sizeof(cacheMisses), "%.2f", result.CacheMissesPerOp);
+
+                std::fprintf(table, "%-*s %5lld %8g %10lld %12.2f %12.2f %12s\n",
+                    nameWidth, result.Name.c_str(), static_cast<long long>(result.MaxDepth), result.Density,
+                    static_cast<long long>(result.LeafCount), result.NsPerOp, result.MinNsPerOp, cacheMisses);
+            }
+        }
+    }
+
+    std::fprintf(table, "\n%5s %8s %10s %16s %22s\n", "depth", "density", "leaves", "cbt heap KiB", "neighbour table KiB");
+    for (const MemoryResult& result : memory)
+    {
+        std::fprintf(table, "%5lld %8g %10lld %16.1f %22.1f\n",
+            static_cast<long long>(result.MaxDepth), result.Density, static_cast<long long>(result.LeafCount),
+            result.HeapByteSize / 1024.0, result.NeighbourTableByteSize / 1024.0);
+    }
+
+    if (!options.JsonPath.empty() && !WriteJson(options.JsonPath, options, results, memory))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", options.JsonPath.c_str());
+        return 1;
+    }
+
+    if (!options.BaselinePath.empty())
+    {
+        if (!CompareWithBaseline(options.BaselinePath, options.Tolerance, baselineNsPerOp, results))
+            return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Counts last level cache misses of the calling thread between Start and Stop.
+// Only available through perf_event_open on Linux; elsewhere, or when perf is not permitted, Stop returns -1.
+class CacheMissCounter
+{
+public:
+    CacheMissCounter()
+    {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_FD = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter()
+    {
+#if defined(__linux__)
+        if (m_FD >= 0) close(m_FD);
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    bool IsAvailable() const { return m_FD >= 0; }
+
+    void Start() const
+    {
+#if defined(__linux__)
+        if (m_FD < 0) return;
+        ioctl(m_FD, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_FD, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    int64_t Stop() const
+    {
+#if defined(__linux__)
+        if (m_FD < 0) return -1;
+        ioctl(m_FD, PERF_EVENT_IOC_DISABLE, 0);
+
+        int64_t count = 0;
+        if (read(m_FD, &count, sizeof(count)) != sizeof(count))
+            return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+
+private:
+    int m_FD = -1;
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+// Heap layouts for the CPU concurrent binary tree (see cbt_tree.h)
+//
+// Every node of the sum-reduction tree stores the number of leaves beneath it, using (maxDepth - depth + 1) bits.
+// libcbt stores the tree level by level (cbt__NodeBitID), so below the first few levels each step of a root to leaf
+// descent touches a new cache line. A layout groups consecutive levels into rows and splits each row into blocks,
+// one per node at the row's first depth, holding that node's subtree down to the row's last depth.
+// The addressing of each depth is captured by a CbtHeapLevel, so that the tree itself is layout agnostic.
+
+struct CbtHeapLevel
+{
+    uint64_t BitOffset;     // Offset of this level within the first block of its row
+    uint64_t BlockBitSize;  // Stride between consecutive blocks of the row
+    uint32_t BlockShift;    // Depth of this level below the first level of its row
+    uint32_t BitSize;       // Width of a node's field at this level
+};
+
+constexpr uint64_t CbtNodeBitID(const CbtHeapLevel& level, uint64_t id, int64_t depth)
+{
+    const uint64_t blockID = (id >> level.BlockShift) - (1ull << (depth - level.BlockShift));
+    const uint64_t localID = id & ((1ull << level.BlockShift) - 1u);
+
+    return level.BitOffset + blockID * level.BlockBitSize + localID * level.BitSize;
+}
+
+constexpr uint64_t CbtBitMask(uint32_t bitSize)
+{
+    return bitSize >= 64u ? ~0ull : (1ull << bitSize) - 1u;
+}
+
+// Fields are at most 59 bits wide but may straddle two words
+constexpr uint64_t CbtReadBits(const uint64_t* heap, uint64_t bitID, uint32_t bitSize)
+{
+    const uint64_t wordID = bitID >> 6u;
+    const uint32_t bitOffset = static_cast<uint32_t>(bitID & 63u);
+    const uint32_t lsbSize = std::min(64u - bitOffset, bitSize);
+    const uint32_t msbSize = bitSize - lsbSize;
+
+    uint64_t value = (heap[wordID] >> bitOffset) & CbtBitMask(lsbSize);
+    if (msbSize > 0u)
+        value |= (heap[wordID + 1u] & CbtBitMask(msbSize)) << lsbSize;
+
+    return value;
+}
+
+constexpr void CbtWriteBits(uint64_t* heap, uint64_t bitID, uint32_t bitSize, uint64_t value)
+{
+    const uint64_t wordID = bitID >> 6u;
+    const uint32_t bitOffset = static_cast<uint32_t>(bitID & 63u);
+    const uint32_t lsbSize = std::min(64u - bitOffset, bitSize);
+    const uint32_t msbSize = bitSize - lsbSize;
+
+    heap[wordID] = (heap[wordID] & ~(CbtBitMask(lsbSize) << bitOffset)) | ((value & CbtBitMask(lsbSize)) << bitOffset);
+    if (msbSize > 0u)
+        heap[wordID + 1u] = (heap[wordID + 1u] & ~CbtBitMask(msbSize)) | (value >> lsbSize);
+}
+
+// Heaps are cache line aligned so that blocked layouts map one block to one line
+inline constexpr size_t g_CbtHeapAlignment = 64;
+
+struct CbtHeapDeleter
+{
+    void operator()(uint64_t* heap) const { ::operator delete[](heap, std::align_val_t{ g_CbtHeapAlignment }); }
+};
+using CbtHeapPtr = std::unique_ptr<uint64_t[], CbtHeapDeleter>;
+
+inline CbtHeapPtr CbtAllocateHeap(uint64_t byteSize)
+{
+    return CbtHeapPtr(static_cast<uint64_t*>(::operator new[](byteSize, std::align_val_t{ g_CbtHeapAlignment })));
+}
+
+// Layout policies
+// Each provides BuildLevels(maxDepth, levels), which fills levels[0..maxDepth] and returns the heap size in bits.
+// Both keep libcbt's convention of storing the max depth as the lowest set bit of the first word.
+
+// One level per row and one node per block, i.e. cbt__NodeBitID.
+// The heap is bit-identical to libcbt's, so it can be handed to cbt_SetHeap or uploaded to the shaders as-is.
+struct CbtLevelMajorLayout
+{
+    static constexpr const char* Name = "LevelMajor";
+
+    // Every level is addressed in closed form, so single levels can be looked up without building the table
+    static constexpr CbtHeapLevel Level(int64_t maxDepth, int64_t depth)
+    {
+        const uint32_t bitSize = static_cast<uint32_t>(maxDepth - depth + 1);
+        return { (2ull << depth) + (1ull << depth) * bitSize, bitSize, 0u, bitSize };
+    }
+
+    static constexpr uint64_t BuildLevels(int64_t maxDepth, CbtHeapLevel* levels)
+    {
+        for (int64_t depth = 0; depth <= maxDepth; depth++)
+            levels[depth] = Level(maxDepth, depth);
+        return 4ull << maxDepth;
+    }
+};
+
+// How CbtBlockedLayout groups levels into rows
+enum class CbtRowSplit
+{
+    // Rows are formed from the leaves up, so that the deepest row, which holds nearly all of the heap, packs the most
+    // levels (8 for the depths used here), and every block is padded to a full cache line. Descents that stop a few
+    // levels above the max depth, as in sparse trees, then touch one line of the large leaf row per leaf.
+    FromLeaves,
+
+    // Rows are formed from the root down, except for the leaf row, which always holds the deepest 7 levels so that
+    // every 64 leaves still share a word. Blocks are only padded to the next power of two bits.
+    // Sparse descents then mostly end in a row of few, densely packed blocks; see README.md for the measured comparison.
+    FromRoot,
+};
+
+// B-tree style blocking: each block is a complete subtree of several levels, at most one cache line in size and
+// aligned so that it never straddles two. Within a block the deepest level comes first, which keeps every run of
+// 64 leaves in a single aligned word.
+template <CbtRowSplit RowSplit = CbtRowSplit::FromRoot>
+struct CbtBlockedLayout
+{
+    static constexpr const char* Name = RowSplit == CbtRowSplit::FromLeaves ? "BlockedFromLeaves" : "BlockedFromRoot";
+    static constexpr uint64_t MaxBlockBitSize = 512; // 64-byte cache line
+    static constexpr int64_t LeafRowLevelCount = 7;  // FromRoot only
+
+    static constexpr uint64_t SubtreeBitSize(int64_t maxDepth, int64_t firstDepth, int64_t lastDepth)
+    {
+        uint64_t bitSize = 0;
+        for (int64_t depth = firstDepth; depth <= lastDepth; depth++)
+            bitSize += (1ull << (depth - firstDepth)) * static_cast<uint64_t>(maxDepth - depth + 1);
+        return bitSize;
+    }
+
+    static constexpr void SetRow(CbtHeapLevel* levels, int64_t firstDepth, int64_t lastDepth)
+    {
+        for (int64_t depth = firstDepth; depth <= lastDepth; depth++)
+            levels[depth].BlockShift = static_cast<uint32_t>(depth - firstDepth);
+    }
+
+    static constexpr uint64_t BuildLevels(int64_t maxDepth, CbtHeapLevel* levels)
+    {
+        // Split the levels into rows
+        if constexpr (RowSplit == CbtRowSplit::FromLeaves)
+        {
+            for (int64_t lastDepth = maxDepth; lastDepth >= 0;)
+            {
+                int64_t firstDepth = lastDepth;
+                while (firstDepth > 0 && SubtreeBitSize(maxDepth, firstDepth - 1, lastDepth) <= MaxBlockBitSize)
+                    firstDepth--;
+
+                SetRow(levels, firstDepth, lastDepth);
+                lastDepth = firstDepth - 1;
+            }
+        }
+        else
+        {
+            const int64_t leafRowDepth = std::max<int64_t>(0, maxDepth - LeafRowLevelCount + 1);
+            SetRow(levels, leafRowDepth, maxDepth);
+
+            for (int64_t firstDepth = 0; firstDepth < leafRowDepth;)
+            {
+                int64_t lastDepth = firstDepth;
+                while (lastDepth + 1 < leafRowDepth && SubtreeBitSize(maxDepth, firstDepth, lastDepth + 1) <= MaxBlockBitSize)
+                    lastDepth++;
+
+                SetRow(levels, firstDepth, lastDepth);
+                firstDepth = lastDepth + 1;
+            }
+        }
+
+        // Assign offsets top down; the first cache line is reserved for the max depth
+        uint64_t rowBitOffset = MaxBlockBitSize;
+        for (int64_t firstDepth = 0; firstDepth <= maxDepth;)
+        {
+            int64_t lastDepth = firstDepth;
+            while (lastDepth < maxDepth && levels[lastDepth + 1].BlockShift > 0u)
+                lastDepth++;
+
+            const uint64_t blockBitSize = RowSplit == CbtRowSplit::FromLeaves
+                ? MaxBlockBitSize
+                : std::bit_ceil(SubtreeBitSize(maxDepth, firstDepth, lastDepth));
+            rowBitOffset = (rowBitOffset + blockBitSize - 1u) & ~(blockBitSize - 1u);
+
+            uint64_t levelBitOffset = 0;
+            for (int64_t depth = lastDepth; depth >= firstDepth; depth--)
+            {
+                const uint32_t bitSize = static_cast<uint32_t>(maxDepth - depth + 1);
+                levels[depth].BitOffset = rowBitOffset + levelBitOffset;
+                levels[depth].BlockBitSize = blockBitSize;
+                levels[depth].BitSize = bitSize;
+
+                levelBitOffset += (1ull << (depth - firstDepth)) * bitSize;
+            }
+
+            rowBitOffset += (1ull << firstDepth) * blockBitSize;
+            firstDepth = lastDepth + 1;
+        }
+
+        // Keeps the heap a whole number of words
+        return (rowBitOffset + 63u) & ~63ull;
+    }
+};
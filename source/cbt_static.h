@@ -0,0 +1,211 @@
+#pragma once
+
+// CPU concurrent binary tree with its max depth fixed at compile time
+// Same interface as CbtTree, but every level's bit offset and field width is a constant, and the descents in
+// DecodeNode / EncodeNode and the sum reduction are unrolled over depth. CbtDispatchMaxDepth selects the
+// instantiation for a runtime depth.
+//
+// As with leb.h, cbt.h must be included before this header.
+
+#include <array>
+#include <type_traits>
+#include <utility>
+
+#include "cbt_tree.h"
+
+// Depth range instantiated by CbtDispatchMaxDepth (matches the MaxDepth slider of the sample)
+inline constexpr int64_t g_CbtMinStaticDepth = 6;
+inline constexpr int64_t g_CbtMaxStaticDepth = 24;
+
+template <int64_t MaxDepth, typename Layout>
+struct CbtStaticLevels
+{
+    std::array<CbtHeapLevel, MaxDepth + 1> Levels{};
+    uint64_t HeapBitSize = 0;
+
+    constexpr CbtStaticLevels()
+    {
+        HeapBitSize = Layout::BuildLevels(MaxDepth, Levels.data());
+    }
+};
+
+template <int64_t MaxDepthT, typename Layout = CbtLevelMajorLayout>
+class Cbt
+{
+    static_assert(MaxDepthT >= 6 && MaxDepthT <= 58, "Cbt supports max depths of 6 to 58");
+
+    inline static constexpr CbtStaticLevels<MaxDepthT, Layout> s_LevelTable{};
+
+    // Every 64 leaves share an aligned word at the depths supported, so the leaves are always reduced a word at a time
+    static_assert(CbtHasPackedLeaves(s_LevelTable.Levels.data(), MaxDepthT), "Cbt requires a layout that packs the leaves");
+
+public:
+    explicit Cbt(int64_t initDepth)
+        : m_Heap(CbtAllocateHeap(HeapByteSize()))
+    {
+        ResetToDepth(initDepth);
+    }
+
+    static constexpr int64_t MaxDepth() { return MaxDepthT; }
+    static constexpr int64_t HeapByteSize() { return static_cast<int64_t>(s_LevelTable.HeapBitSize >> 3u); }
+    static constexpr int64_t LevelMajorHeapByteSize() { return CbtLevelMajorHeapByteSize(MaxDepthT); }
+    const uint64_t* GetHeap() const { return m_Heap.get(); }
+
+    template <int64_t Depth>
+    uint64_t HeapRead(uint64_t id) const
+    {
+        constexpr CbtHeapLevel level = s_LevelTable.Levels[Depth];
+        return CbtReadBits(m_Heap.get(), CbtNodeBitID(level, id, Depth), level.BitSize);
+    }
+
+    template <int64_t Depth>
+    void HeapWrite(uint64_t id, uint64_t value)
+    {
+        constexpr CbtHeapLevel level = s_LevelTable.Levels[Depth];
+        CbtWriteBits(m_Heap.get(), CbtNodeBitID(level, id, Depth), level.BitSize, value);
+    }
+
+    uint64_t HeapRead(const cbt_Node node) const
+    {
+        const CbtHeapLevel& level = s_LevelTable.Levels[node.depth];
+        return CbtReadBits(m_Heap.get(), CbtNodeBitID(level, node.id, node.depth), level.BitSize);
+    }
+
+    void HeapWrite(const cbt_Node node, uint64_t value)
+    {
+        const CbtHeapLevel& level = s_LevelTable.Levels[node.depth];
+        CbtWriteBits(m_Heap.get(), CbtNodeBitID(level, node.id, node.depth), level.BitSize, value);
+    }
+
+    int64_t NodeCount() const { return static_cast<int64_t>(HeapRead<0>(1u)); }
+
+    bool IsLeafNode(const cbt_Node node) const { return HeapRead(node) == 1u; }
+    bool IsCeilNode(const cbt_Node node) const { return static_cast<int64_t>(node.depth) == MaxDepthT; }
+
+    // Ceil nodes always live at the max depth, so splits and merges only ever touch the leaf level
+    void SplitNode(const cbt_Node node)
+    {
+        if (!IsCeilNode(node))
+            HeapWrite<MaxDepthT>((node.id << 1u | 1u) << (MaxDepthT - node.depth - 1), 1u);
+    }
+
+    void MergeNode(const cbt_Node node)
+    {
+        if (node.id > 1u)
+            HeapWrite<MaxDepthT>((node.id | 1u) << (MaxDepthT - node.depth), 0u);
+    }
+
+    cbt_Node DecodeNode(int64_t handle) const
+    {
+        uint64_t id = 1u;
+        uint64_t nodeCount = HeapRead<0>(id);
+
+        // One step per level, stopping at the first leaf
+        [&]<int64_t... Depths>(std::integer_sequence<int64_t, Depths...>)
+        {
+            ((nodeCount > 1u && (DecodeStep<Depths + 1>(id, handle, nodeCount), true)) && ...);
+        }(std::make_integer_sequence<int64_t, MaxDepthT>{});
+
+        return CbtMakeNode(id, std::bit_width(id) - 1);
+    }
+
+    int64_t EncodeNode(const cbt_Node node) const
+    {
+        const int64_t depth = node.depth;
+        int64_t handle = 0;
+
+        // Adds the left sibling's count at each level on the path where the path goes right
+        [&]<int64_t... Depths>(std::integer_sequence<int64_t, Depths...>)
+        {
+            ((handle += Depths < depth ? EncodeStep<Depths + 1>(node.id >> (depth - Depths - 1)) : 0), ...);
+        }(std::make_integer_sequence<int64_t, MaxDepthT>{});
+
+        return handle;
+    }
+
+    void ResetToDepth(int64_t depth)
+    {
+        CbtResetHeap(m_Heap.get(), HeapByteSize(), s_LevelTable.Levels.data(), MaxDepthT, depth);
+        ComputeSumReduction();
+    }
+
+    void ComputeSumReduction()
+    {
+        CbtReducePackedLeaves(m_Heap.get(), s_LevelTable.Levels.data(), MaxDepthT);
+        ReduceRows<MaxDepthT - 2>();
+    }
+
+    template <typename Callback>
+    void Update(Callback&& callback) { CbtUpdate(*this, callback); }
+
+    void WriteLevelMajorHeap(void* dst) const
+    {
+        CbtWriteLevelMajorHeap<Layout>(m_Heap.get(), s_LevelTable.Levels.data(), MaxDepthT, dst);
+    }
+
+    void SetLevelMajorHeap(const void* src)
+    {
+        CbtSetLevelMajorLeaves(m_Heap.get(), HeapByteSize(), s_LevelTable.Levels.data(), MaxDepthT, src);
+        ComputeSumReduction();
+    }
+
+private:
+    template <int64_t ChildDepth>
+    void DecodeStep(uint64_t& id, int64_t& handle, uint64_t& nodeCount) const
+    {
+        const uint64_t leftCount = HeapRead<ChildDepth>(id << 1u);
+        const uint64_t b = static_cast<uint64_t>(handle) < leftCount ? 0u : 1u;
+
+        id = id << 1u | b;
+        handle -= static_cast<int64_t>(leftCount * b);
+        nodeCount = b ? nodeCount - leftCount : leftCount;
+    }
+
+    template <int64_t Depth>
+    int64_t EncodeStep(uint64_t id) const
+    {
+        return (id & 1u) ? static_cast<int64_t>(HeapRead<Depth>(id ^ 1u)) : 0;
+    }
+
+    // Same row / block order as CbtTree::ComputeSumReduction, with the row boundaries resolved at compile time
+    template <int64_t LastDepth>
+    void ReduceRows()
+    {
+        if constexpr (LastDepth >= 0)
+        {
+            constexpr int64_t firstDepth = LastDepth - s_LevelTable.Levels[LastDepth].BlockShift;
+
+            for (uint64_t blockID = 1ull << firstDepth; blockID < (2ull << firstDepth); blockID++)
+            {
+                [&]<int64_t... Offsets>(std::integer_sequence<int64_t, Offsets...>)
+                {
+                    (ReduceBlockLevel<LastDepth - Offsets, firstDepth>(blockID), ...);
+                }(std::make_integer_sequence<int64_t, LastDepth - firstDepth + 1>{});
+            }
+
+            ReduceRows<firstDepth - 1>();
+        }
+    }
+
+    template <int64_t Depth, int64_t FirstDepth>
+    void ReduceBlockLevel(uint64_t blockID)
+    {
+        constexpr int64_t shift = Depth - FirstDepth;
+        for (uint64_t id = blockID << shift; id < (blockID + 1u) << shift; id++)
+            HeapWrite<Depth>(id, HeapRead<Depth + 1>(id << 1u) + HeapRead<Depth + 1>(id << 1u | 1u));
+    }
+
+    CbtHeapPtr m_Heap;
+};
+
+// Calls f(std::integral_constant<int64_t, maxDepth>) so that the callee can instantiate Cbt<maxDepth>
+// Returns false if maxDepth is outside [g_CbtMinStaticDepth, g_CbtMaxStaticDepth]
+template <typename F>
+bool CbtDispatchMaxDepth(int64_t maxDepth, F&& f)
+{
+    return [&]<int64_t... Offsets>(std::integer_sequence<int64_t, Offsets...>)
+    {
+        return ((maxDepth == g_CbtMinStaticDepth + Offsets
+            && (f(std::integral_constant<int64_t, g_CbtMinStaticDepth + Offsets>{}), true)) || ...);
+    }(std::make_integer_sequence<int64_t, g_CbtMaxStaticDepth - g_CbtMinStaticDepth + 1>{});
+}
@@ -0,0 +1,287 @@
+#pragma once
+
+// CPU concurrent binary tree with a pluggable heap layout (see cbt_layout.h)
+// Mirrors the part of the libcbt API used by the CPU backend. Nodes are plain cbt_Nodes so the leb.h helpers
+// (attribute decoding, diamond parents) can be used on them unchanged.
+//
+// This is a prototype for cbt_bench only; the sample's CPU backend still runs libcbt's cbt_Tree. SplitNode and
+// MergeNode are the raw CBT bit flips: leb_SplitNode_Square / leb_MergeNode_Square only take a cbt_Tree*, so
+// conforming LEB splits and merges are not available on this tree.
+//
+// As with leb.h, cbt.h must be included before this header.
+
+#include <bit>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "cbt_layout.h"
+
+inline cbt_Node CbtMakeNode(uint64_t id, int64_t depth)
+{
+    cbt_Node node;
+    node.id = id;
+    node.depth = depth;
+    return node;
+}
+
+// Heap operations shared by CbtTree and Cbt<MaxDepth>, parameterised on the tree's level table (levels[0..maxDepth])
+
+// Leaves can be copied and reduced a word at a time when every 64 of them share an aligned word
+constexpr bool CbtHasPackedLeaves(const CbtHeapLevel* levels, int64_t maxDepth)
+{
+    const CbtHeapLevel& leafLevel = levels[maxDepth];
+    return maxDepth >= 6
+        && (leafLevel.BlockShift >= 6u || leafLevel.BlockBitSize == leafLevel.BitSize)
+        && CbtNodeBitID(leafLevel, 1ull << maxDepth, maxDepth) % 64u == 0u;
+}
+
+// Size of the equivalent libcbt heap (cbt_HeapByteSize)
+constexpr int64_t CbtLevelMajorHeapByteSize(int64_t maxDepth)
+{
+    return 1ll << (maxDepth - 1);
+}
+
+// Zeroes the heap, keeping libcbt's max depth bit in the first word
+inline void CbtClearHeap(uint64_t* heap, int64_t byteSize, int64_t maxDepth)
+{
+    std::memset(heap, 0, byteSize);
+    heap[0] = 1ull << maxDepth;
+}
+
+// Sets every node at depth as a leaf; the caller then runs the sum reduction
+inline void CbtResetHeap(uint64_t* heap, int64_t byteSize, const CbtHeapLevel* levels, int64_t maxDepth, int64_t depth)
+{
+    const CbtHeapLevel& leafLevel = levels[maxDepth];
+
+    CbtClearHeap(heap, byteSize, maxDepth);
+    for (uint64_t id = 1ull << depth; id < (2ull << depth); id++)
+        CbtWriteBits(heap, CbtNodeBitID(leafLevel, id << (maxDepth - depth), maxDepth), leafLevel.BitSize, 1u);
+}
+
+// First level of the sum reduction when the leaves are packed: one word read per 32 parents
+inline void CbtReducePackedLeaves(uint64_t* heap, const CbtHeapLevel* levels, int64_t maxDepth)
+{
+    const CbtHeapLevel& leafLevel = levels[maxDepth];
+    const CbtHeapLevel& parentLevel = levels[maxDepth - 1];
+
+    for (uint64_t id = 1ull << maxDepth; id < (2ull << maxDepth); id += 64u)
+    {
+        const uint64_t bitField = heap[CbtNodeBitID(leafLevel, id, maxDepth) >> 6u];
+        for (uint32_t i = 0; i < 32u; i++)
+        {
+            const uint64_t bitCount = std::popcount((bitField >> (i << 1u)) & 3u);
+            CbtWriteBits(heap, CbtNodeBitID(parentLevel, (id >> 1u) + i, maxDepth - 1), parentLevel.BitSize, bitCount);
+        }
+    }
+}
+
+// Writes the heap in libcbt's layout (CbtLevelMajorHeapByteSize bytes), e.g. for the shaders or cbt_SetHeap
+template <typename Layout>
+void CbtWriteLevelMajorHeap(const uint64_t* heap, const CbtHeapLevel* levels, int64_t maxDepth, void* dst)
+{
+    if constexpr (std::is_same_v<Layout, CbtLevelMajorLayout>)
+    {
+        std::memcpy(dst, heap, CbtLevelMajorHeapByteSize(maxDepth));
+    }
+    else
+    {
+        uint64_t* levelMajorHeap = static_cast<uint64_t*>(dst);
+        CbtClearHeap(levelMajorHeap, CbtLevelMajorHeapByteSize(maxDepth), maxDepth);
+
+        for (int64_t depth = 0; depth <= maxDepth; depth++)
+        {
+            const CbtHeapLevel& level = levels[depth];
+            const CbtHeapLevel levelMajorLevel = CbtLevelMajorLayout::Level(maxDepth, depth);
+            for (uint64_t id = 1ull << depth; id < (2ull << depth); id++)
+            {
+                const uint64_t value = CbtReadBits(heap, CbtNodeBitID(level, id, depth), level.BitSize);
+                CbtWriteBits(levelMajorHeap, CbtNodeBitID(levelMajorLevel, id, depth), levelMajorLevel.BitSize, value);
+            }
+        }
+    }
+}
+
+// Loads the leaves of a heap in libcbt's layout (e.g. cbt_GetHeap); the caller then runs the sum reduction
+inline void CbtSetLevelMajorLeaves(uint64_t* heap, int64_t byteSize, const CbtHeapLevel* levels, int64_t maxDepth, const void* src)
+{
+    const uint64_t* levelMajorHeap = static_cast<const uint64_t*>(src);
+    const CbtHeapLevel& leafLevel = levels[maxDepth];
+    const CbtHeapLevel levelMajorLeafLevel = CbtLevelMajorLayout::Level(maxDepth, maxDepth);
+    const bool packedLeaves = CbtHasPackedLeaves(levels, maxDepth);
+
+    CbtClearHeap(heap, byteSize, maxDepth);
+    for (uint64_t id = 1ull << maxDepth; id < (2ull << maxDepth); id += packedLeaves ? 64u : 1u)
+    {
+        const uint64_t srcBitID = CbtNodeBitID(levelMajorLeafLevel, id, maxDepth);
+        if (packedLeaves)
+            heap[CbtNodeBitID(leafLevel, id, maxDepth) >> 6u] = levelMajorHeap[srcBitID >> 6u];
+        else
+            CbtWriteBits(heap, CbtNodeBitID(leafLevel, id, maxDepth), leafLevel.BitSize, CbtReadBits(levelMajorHeap, srcBitID, 1u));
+    }
+}
+
+// Equivalent of cbt_Update: callback(tree, leaf) for every leaf, followed by a sum reduction
+template <typename Tree, typename Callback>
+void CbtUpdate(Tree& tree, Callback&& callback)
+{
+    const int64_t nodeCount = tree.NodeCount();
+    for (int64_t handle = 0; handle < nodeCount; handle++)
+        callback(tree, tree.DecodeNode(handle));
+
+    tree.ComputeSumReduction();
+}
+
+template <typename Layout>
+class CbtTree
+{
+public:
+    CbtTree(int64_t maxDepth, int64_t initDepth)
+        : m_MaxDepth(maxDepth)
+        , m_Levels(static_cast<size_t>(maxDepth + 1))
+    {
+        m_HeapBitSize = Layout::BuildLevels(maxDepth, m_Levels.data());
+        m_Heap = CbtAllocateHeap(HeapByteSize());
+        m_PackedLeaves = CbtHasPackedLeaves(m_Levels.data(), maxDepth);
+
+        ResetToDepth(initDepth);
+    }
+
+    int64_t MaxDepth() const { return m_MaxDepth; }
+    int64_t HeapByteSize() const { return static_cast<int64_t>(m_HeapBitSize >> 3u); }
+    const uint64_t* GetHeap() const { return m_Heap.get(); }
+
+    int64_t LevelMajorHeapByteSize() const { return CbtLevelMajorHeapByteSize(m_MaxDepth); }
+
+    uint64_t HeapRead(const cbt_Node node) const
+    {
+        const CbtHeapLevel& level = m_Levels[node.depth];
+        return CbtReadBits(m_Heap.get(), CbtNodeBitID(level, node.id, node.depth), level.BitSize);
+    }
+
+    void HeapWrite(const cbt_Node node, uint64_t value)
+    {
+        const CbtHeapLevel& level = m_Levels[node.depth];
+        CbtWriteBits(m_Heap.get(), CbtNodeBitID(level, node.id, node.depth), level.BitSize, value);
+    }
+
+    int64_t NodeCount() const { return static_cast<int64_t>(HeapRead(CbtMakeNode(1u, 0))); }
+
+    bool IsLeafNode(const cbt_Node node) const { return HeapRead(node) == 1u; }
+    bool IsCeilNode(const cbt_Node node) const { return static_cast<int64_t>(node.depth) == m_MaxDepth; }
+
+    void SplitNode(const cbt_Node node)
+    {
+        if (!IsCeilNode(node))
+            HeapWrite(CeilNode(node.id << 1u | 1u, node.depth + 1), 1u);
+    }
+
+    void MergeNode(const cbt_Node node)
+    {
+        if (node.id > 1u)
+            HeapWrite(CeilNode(node.id | 1u, node.depth), 0u);
+    }
+
+    // Same traversal as cbt_DecodeNode, but the current node's count is carried down so each level costs one read
+    cbt_Node DecodeNode(int64_t handle) const
+    {
+        uint64_t id = 1u;
+        int64_t depth = 0;
+        uint64_t nodeCount = HeapRead(CbtMakeNode(id, depth));
+
+        while (nodeCount > 1u)
+        {
+            const uint64_t leftCount = HeapRead(CbtMakeNode(id << 1u, depth + 1));
+            const uint64_t b = static_cast<uint64_t>(handle) < leftCount ? 0u : 1u;
+
+            id = id << 1u | b;
+            depth++;
+            handle -= static_cast<int64_t>(leftCount * b);
+            nodeCount = b ? nodeCount - leftCount : leftCount;
+        }
+
+        return CbtMakeNode(id, depth);
+    }
+
+    int64_t EncodeNode(const cbt_Node node) const
+    {
+        int64_t handle = 0;
+        uint64_t id = node.id;
+        int64_t depth = node.depth;
+
+        while (id > 1u)
+        {
+            if (id & 1u)
+                handle += static_cast<int64_t>(HeapRead(CbtMakeNode(id ^ 1u, depth)));
+            id >>= 1u;
+            depth--;
+        }
+
+        return handle;
+    }
+
+    void ResetToDepth(int64_t depth)
+    {
+        CbtResetHeap(m_Heap.get(), HeapByteSize(), m_Levels.data(), m_MaxDepth, depth);
+        ComputeSumReduction();
+    }
+
+    void ComputeSumReduction()
+    {
+        int64_t lastDepth = m_MaxDepth - 1;
+
+        if (m_PackedLeaves)
+        {
+            CbtReducePackedLeaves(m_Heap.get(), m_Levels.data(), m_MaxDepth);
+            lastDepth--;
+        }
+
+        // Rows bottom up, finishing each block's subtree before moving on to the next block
+        while (lastDepth >= 0)
+        {
+            const int64_t firstDepth = lastDepth - m_Levels[lastDepth].BlockShift;
+
+            for (uint64_t blockID = 1ull << firstDepth; blockID < (2ull << firstDepth); blockID++)
+            {
+                for (int64_t depth = lastDepth; depth >= firstDepth; depth--)
+                {
+                    const int64_t shift = depth - firstDepth;
+                    for (uint64_t id = blockID << shift; id < (blockID + 1u) << shift; id++)
+                    {
+                        const uint64_t x0 = HeapRead(CbtMakeNode(id << 1u, depth + 1));
+                        const uint64_t x1 = HeapRead(CbtMakeNode(id << 1u | 1u, depth + 1));
+                        HeapWrite(CbtMakeNode(id, depth), x0 + x1);
+                    }
+                }
+            }
+
+            lastDepth = firstDepth - 1;
+        }
+    }
+
+    template <typename Callback>
+    void Update(Callback&& callback) { CbtUpdate(*this, callback); }
+
+    void WriteLevelMajorHeap(void* dst) const
+    {
+        CbtWriteLevelMajorHeap<Layout>(m_Heap.get(), m_Levels.data(), m_MaxDepth, dst);
+    }
+
+    void SetLevelMajorHeap(const void* src)
+    {
+        CbtSetLevelMajorLeaves(m_Heap.get(), HeapByteSize(), m_Levels.data(), m_MaxDepth, src);
+        ComputeSumReduction();
+    }
+
+private:
+    cbt_Node CeilNode(uint64_t id, int64_t depth) const
+    {
+        return CbtMakeNode(id << (m_MaxDepth - depth), m_MaxDepth);
+    }
+
+    int64_t m_MaxDepth;
+    std::vector<CbtHeapLevel> m_Levels;
+    uint64_t m_HeapBitSize = 0;
+    bool m_PackedLeaves = false;
+    CbtHeapPtr m_Heap;
+};
@@ -0,0 +1,273 @@
+#pragma once
+
+// Same-depth neighbour IDs of every leaf of an LEB square, kept up to date through splits and merges
+//
+// libleb finds a node's neighbours by replaying its bisection path from the root (leb__DecodeSameDepthNeighborIDs),
+// i.e. O(depth) work, and leb_SplitNode_Square does so at every step of the split chain it walks to the boundary.
+// Neighbour IDs only depend on a node's ID, and a child's can be derived from its parent's in O(1) (and vice versa),
+// so this table stores them for the current leaves and updates them as leaves are split or merged. Split propagation
+// then costs O(1) per step and stops as soon as the mesh is conforming, and diamond parents are a single lookup.
+//
+// This costs memory. Each leaf takes a 32 byte entry in a table that Build and growth leave 3/8 to 3/4 full (merges
+// can leave it emptier), i.e. 43 to 85 bytes per leaf, while the CBT heap needs 2^(maxDepth - 1) bytes in total.
+// At depth 24 the table matches the 8 MiB heap with 0.2M leaves but takes 128 MiB with 1.9M leaves. Each successful
+// merge also updates six entries. See cbt_bench's LebNeighbourTable cases to compare against libleb.
+//
+// Only valid while the tree is modified through the table; call Build after any other change (e.g. cbt_ResetToDepth).
+// Not thread safe, so cbt_Update must run serially (the default, as libcbt is built without OpenMP).
+//
+// As with leb.h, cbt.h and leb.h must be included before this header.
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Same layout as libleb's leb__SameDepthNeighborIDs, minus the node's own ID
+struct LebNeighbourIDs
+{
+    uint64_t Left;
+    uint64_t Right;
+    uint64_t Edge;  // Neighbour across the longest edge, 0 on the boundary
+};
+
+// IDs of the child (nodeID << 1 | splitBit), matching leb__SplitNodeIDs
+inline LebNeighbourIDs LebSplitNeighbourIDs(const LebNeighbourIDs& ids, uint64_t nodeID, uint64_t splitBit)
+{
+    if (splitBit == 0u)
+        return { nodeID << 1u | 1u, ids.Edge << 1u | (ids.Edge ? 1u : 0u), ids.Right << 1u | (ids.Right ? 1u : 0u) };
+    else
+        return { ids.Edge << 1u, nodeID << 1u, ids.Left << 1u };
+}
+
+// Inverse of LebSplitNeighbourIDs, from the IDs of both children
+inline LebNeighbourIDs LebMergeNeighbourIDs(const LebNeighbourIDs& leftChild, const LebNeighbourIDs& rightChild)
+{
+    return { rightChild.Edge >> 1u, leftChild.Edge >> 1u, rightChild.Left >> 1u };
+}
+
+class LebNeighbourTable
+{
+public:
+    // Walks down from the root, deriving each node's IDs from its parent's, so this costs O(leaf count)
+    // The tree must be at least at depth 1, as the square's two initial triangles are its depth 1 nodes
+    void Build(const cbt_Tree* tree)
+    {
+        // Just large enough for the current leaves at Insert's 3/4 load limit; splits grow it when needed
+        const size_t leafCount = static_cast<size_t>(cbt_NodeCount(tree));
+        Reset(std::bit_ceil(std::max<size_t>(16u, (4u * leafCount + 2u) / 3u)));
+
+        struct StackEntry
+        {
+            cbt_Node Node;
+            LebNeighbourIDs IDs;
+        };
+        std::vector<StackEntry> stack = {
+            { cbt_CreateNode(3u, 1), { 0u, 0u, 2u } },
+            { cbt_CreateNode(2u, 1), { 0u, 0u, 3u } }
+        };
+
+        while (!stack.empty())
+        {
+            const StackEntry entry = stack.back();
+            stack.pop_back();
+
+            if (cbt_IsLeafNode(tree, entry.Node) || cbt_IsCeilNode(tree, entry.Node))
+            {
+                Insert(entry.Node.id, entry.IDs);
+                continue;
+            }
+
+            stack.push_back({ cbt_RightChildNode(entry.Node), LebSplitNeighbourIDs(entry.IDs, entry.Node.id, 1u) });
+            stack.push_back({ cbt_LeftChildNode(entry.Node), LebSplitNeighbourIDs(entry.IDs, entry.Node.id, 0u) });
+        }
+    }
+
+    size_t LeafCount() const { return m_Count; }
+    size_t ByteSize() const { return m_Entries.size() * sizeof(Entry); }
+
+    bool IsLeaf(uint64_t id) const { return FindSlot(id) != s_InvalidSlot; }
+
+    // nullptr if the node is not a leaf
+    const LebNeighbourIDs* Find(uint64_t id) const
+    {
+        const size_t slot = FindSlot(id);
+        return slot != s_InvalidSlot ? &m_Entries[slot].IDs : nullptr;
+    }
+
+    // Equivalent of leb_SplitNode_Square
+    // Nodes that are no longer leaves (e.g. split earlier in the same cbt_Update) are ignored
+    void SplitNode(cbt_Tree* tree, const cbt_Node node)
+    {
+        if (cbt_IsCeilNode(tree, node))
+            return;
+
+        const LebNeighbourIDs* ids = Find(node.id);
+        if (!ids)
+            return;
+
+        // In a conforming mesh the edge neighbour is either a leaf or part of its coarser parent,
+        // which has to be split first
+        const uint64_t edgeID = ids->Edge;
+        if (edgeID != 0u && !IsLeaf(edgeID))
+        {
+            SplitNode(tree, cbt_CreateNode(edgeID >> 1u, node.depth - 1));
+            if (!IsLeaf(edgeID))
+                return;
+        }
+
+        SplitLeaf(tree, node);
+        if (edgeID != 0u)
+            SplitLeaf(tree, cbt_CreateNode(edgeID, node.depth));
+    }
+
+    // Equivalent of leb_DecodeDiamondParent_Square, in O(1) for leaves
+    leb_DiamondParent DecodeDiamondParent(const cbt_Node node) const
+    {
+        const LebNeighbourIDs* ids = Find(node.id);
+        if (!ids || node.depth < 2)
+            return leb_DecodeDiamondParent_Square(node);
+
+        // The parent's edge neighbour is part of either child's IDs
+        const cbt_Node base = cbt_ParentNode(node);
+        const uint64_t edgeID = (node.id & 1u) ? ids->Left >> 1u : ids->Right >> 1u;
+
+        leb_DiamondParent diamond;
+        diamond.base = base;
+        diamond.top = cbt_CreateNode(edgeID != 0u ? edgeID : base.id, base.depth);
+        return diamond;
+    }
+
+    // Equivalent of leb_MergeNode_Square
+    void MergeNode(cbt_Tree* tree, const cbt_Node node, const leb_DiamondParent& diamond)
+    {
+        if (node.depth < 2)
+            return;
+
+        const cbt_Node dual = cbt_RightChildNode(diamond.top);
+        if (!IsMergeableLeaf(tree, cbt_SiblingNode(node)) || !IsMergeableLeaf(tree, dual) || !IsMergeableLeaf(tree, cbt_SiblingNode(dual))
+            || !IsLeaf(node.id))
+            return;
+
+        cbt_MergeNode(tree, node);
+        MergeChildren(diamond.base);
+
+        if (diamond.top.id != diamond.base.id)
+        {
+            cbt_MergeNode(tree, dual);
+            MergeChildren(diamond.top);
+        }
+    }
+
+private:
+    // Leaves created by a merge are in the table straight away, but the tree's sums still count their children until
+    // the next reduction. libleb only sees the sums, so checking both keeps merges to one level per cbt_Update.
+    bool IsMergeableLeaf(const cbt_Tree* tree, const cbt_Node node) const
+    {
+        return cbt_IsLeafNode(tree, node) && IsLeaf(node.id);
+    }
+
+    void SplitLeaf(cbt_Tree* tree, const cbt_Node node)
+    {
+        const LebNeighbourIDs ids = Remove(node.id);
+
+        cbt_SplitNode(tree, node);
+        Insert(node.id << 1u, LebSplitNeighbourIDs(ids, node.id, 0u));
+        Insert(node.id << 1u | 1u, LebSplitNeighbourIDs(ids, node.id, 1u));
+    }
+
+    void MergeChildren(const cbt_Node parent)
+    {
+        const LebNeighbourIDs leftChild = Remove(parent.id << 1u);
+        const LebNeighbourIDs rightChild = Remove(parent.id << 1u | 1u);
+        Insert(parent.id, LebMergeNeighbourIDs(leftChild, rightChild));
+    }
+
+    // Open addressing with linear probing, keyed by node ID (IDs start at 1, so 0 marks an empty slot)
+    // Leaves are added and removed on every split and merge, which a node based map would turn into allocations.
+    struct Entry
+    {
+        uint64_t ID;
+        LebNeighbourIDs IDs;
+    };
+
+    inline static constexpr size_t s_InvalidSlot = ~size_t(0);
+
+    size_t HomeSlot(uint64_t id) const
+    {
+        // Fibonacci hashing; consecutive IDs (siblings, a node's descendants) land far apart
+        return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> m_HashShift);
+    }
+
+    size_t FindSlot(uint64_t id) const
+    {
+        if (m_Entries.empty())
+            return s_InvalidSlot;
+
+        const size_t mask = m_Entries.size() - 1u;
+        for (size_t slot = HomeSlot(id); m_Entries[slot].ID != 0u; slot = (slot + 1u) & mask)
+        {
+            if (m_Entries[slot].ID == id)
+                return slot;
+        }
+        return s_InvalidSlot;
+    }
+
+    void Reset(size_t capacity)
+    {
+        m_Entries.assign(capacity, Entry{});
+        m_Count = 0;
+        m_HashShift = 64u - static_cast<uint32_t>(std::countr_zero(capacity));
+    }
+
+    // id must not be in the table
+    void Insert(uint64_t id, const LebNeighbourIDs& ids)
+    {
+        // Kept at most 3/4 full
+        if (4u * (m_Count + 1u) > 3u * m_Entries.size())
+        {
+            std::vector<Entry> entries = std::move(m_Entries);
+            Reset(std::max<size_t>(16u, 2u * entries.size()));
+            for (const Entry& entry : entries)
+            {
+                if (entry.ID != 0u)
+                    Insert(entry.ID, entry.IDs);
+            }
+        }
+
+        const size_t mask = m_Entries.size() - 1u;
+        size_t slot = HomeSlot(id);
+        while (m_Entries[slot].ID != 0u)
+            slot = (slot + 1u) & mask;
+
+        m_Entries[slot] = { id, ids };
+        m_Count++;
+    }
+
+    // id must be in the table
+    LebNeighbourIDs Remove(uint64_t id)
+    {
+        const size_t mask = m_Entries.size() - 1u;
+        size_t hole = FindSlot(id);
+        const LebNeighbourIDs ids = m_Entries[hole].IDs;
+
+        // Backward shift deletion: pull later entries of the probe sequence into the hole, unless that would move them
+        // before their home slot
+        for (size_t slot = (hole + 1u) & mask; m_Entries[slot].ID != 0u; slot = (slot + 1u) & mask)
+        {
+            if (((slot - HomeSlot(m_Entries[slot].ID)) & mask) >= ((slot - hole) & mask))
+            {
+                m_Entries[hole] = m_Entries[slot];
+                hole = slot;
+            }
+        }
+
+        m_Entries[hole].ID = 0u;
+        m_Count--;
+        return ids;
+    }
+
+    std::vector<Entry> m_Entries;
+    size_t m_Count = 0;
+    uint32_t m_HashShift = 64;
+};
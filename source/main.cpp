@@ -16,6 +16,7 @@
 #include "leb.h"
 
 #include "cbt_shared.h"
+#include "subdivision_cpu.h"
 
 using namespace donut;
 using namespace donut::math;
@@ -55,6 +56,7 @@ struct UIData
 {
     Backends Backend = Backend_GPU;
     DisplayModes DisplayMode = DisplayMode_Wireframe;
+    bool UseNeighbourTable = false; // CPU backend only
 
 	float2 Target{ 0.2371f, 0.7104f };
     int CBTMaxDepth = 12;
@@ -63,78 +65,9 @@ struct UIData
 
     // Updated by the application to display in the UI (in milliseconds)
     std::array<float, Timer_COUNT> TimerData{};
+    size_t NeighbourTableByteSize = 0;
 };
 
-// Methods for performing CBT split / merge logic on the CPU
-float Wedge(const float* a, const float* b)
-{
-    return a[0] * b[1] - a[1] * b[0];
-}
-
-bool IsInside(const float faceVertices[][3], float2 t)
-{
-    float target[2] = { t.x, t.y };
-    float v1[2] = { faceVertices[0][0], faceVertices[1][0] };
-    float v2[2] = { faceVertices[0][1], faceVertices[1][1] };
-    float v3[2] = { faceVertices[0][2], faceVertices[1][2] };
-    float x1[2] = { v2[0] - v1[0], v2[1] - v1[1] };
-    float x2[2] = { v3[0] - v2[0], v3[1] - v2[1] };
-    float x3[2] = { v1[0] - v3[0], v1[1] - v3[1] };
-    float y1[2] = { target[0] - v1[0], target[1] - v1[1] };
-    float y2[2] = { target[0] - v2[0], target[1] - v2[1] };
-    float y3[2] = { target[0] - v3[0], target[1] - v3[1] };
-    float w1 = Wedge(x1, y1);
-    float w2 = Wedge(x2, y2);
-    float w3 = Wedge(x3, y3);
-
-    return (w1 >= 0.0f) && (w2 >= 0.0f) && (w3 >= 0.0f);
-}
-
-void UpdateSubdivisionCpuCallback_Split(
-    cbt_Tree* cbt,
-    const cbt_Node node,
-    const void* userData
-) {
-    const float2* target = reinterpret_cast<const float2*>(userData);
-
-    float faceVertices[][3] = {
-        {0.0f, 0.0f, 1.0f},
-        {1.0f, 0.0f, 0.0f}
-    };
-
-    leb_DecodeNodeAttributeArray_Square(node, 2, faceVertices);
-
-    if (IsInside(faceVertices, *target)) {
-        leb_SplitNode_Square(cbt, node);
-    }
-}
-
-void UpdateSubdivisionCpuCallback_Merge(
-    cbt_Tree* cbt,
-    const cbt_Node node,
-    const void* userData
-) {
-    const float2* target = reinterpret_cast<const float2*>(userData);
-
-    float baseFaceVertices[][3] = {
-        {0.0f, 0.0f, 1.0f},
-        {1.0f, 0.0f, 0.0f}
-    };
-    float topFaceVertices[][3] = {
-        {0.0f, 0.0f, 1.0f},
-        {1.0f, 0.0f, 0.0f}
-    };
-
-    leb_DiamondParent diamondParent = leb_DecodeDiamondParent_Square(node);
-
-    leb_DecodeNodeAttributeArray_Square(diamondParent.base, 2, baseFaceVertices);
-    leb_DecodeNodeAttributeArray_Square(diamondParent.top, 2, topFaceVertices);
-
-    if (!IsInside(baseFaceVertices, *target) && !IsInside(topFaceVertices, *target)) {
-        leb_MergeNode_Square(cbt, node, diamondParent);
-    }
-}
-
 class CBTSubdivision : public app::IRenderPass
 {
 private:
@@ -206,6 +139,10 @@ private:
     inline static constexpr uint s_CBTInitDepth = 1;
     nvrhi::BufferHandle m_CBTBuffer;
 
+    // Only kept up to date while in use, so it is rebuilt whenever it is switched on or the tree is recreated / reset
+    LebNeighbourTable m_NeighbourTable;
+    bool m_NeighbourTableValid = false;
+
     std::vector<std::array<nvrhi::TimerQueryHandle, Timer_COUNT>> m_Timers; // One set of timers per back buffer to avoid blocking
     uint m_TimerSetIndex = 0;
 
@@ -464,10 +401,33 @@ public:
 
         if (m_UI.Backend == Backend_CPU)
         {
-            if (pingPong == 0) 
-                cbt_Update(m_CBT, &UpdateSubdivisionCpuCallback_Split, &m_UI.Target);
+            const float target[2] = { m_UI.Target.x, m_UI.Target.y };
+
+            if (m_UI.UseNeighbourTable)
+            {
+                if (!m_NeighbourTableValid)
+                {
+                    m_NeighbourTable.Build(m_CBT);
+                    m_NeighbourTableValid = true;
+                }
+
+                const SubdivisionCpuTableData data = { target, &m_NeighbourTable };
+                if (pingPong == 0)
+                    cbt_Update(m_CBT, &UpdateSubdivisionCpuTableCallback_Split, &data);
+                else
+                    cbt_Update(m_CBT, &UpdateSubdivisionCpuTableCallback_Merge, &data);
+
+                m_UI.NeighbourTableByteSize = m_NeighbourTable.ByteSize();
+            }
             else
-                cbt_Update(m_CBT, &UpdateSubdivisionCpuCallback_Merge, &m_UI.Target);
+            {
+                if (pingPong == 0) 
+                    cbt_Update(m_CBT, &UpdateSubdivisionCpuCallback_Split, target);
+                else
+                    cbt_Update(m_CBT, &UpdateSubdivisionCpuCallback_Merge, target);
+
+                m_NeighbourTableValid = false;
+            }
 
             CopyToCBTBuffer();
         }
@@ -640,6 +600,7 @@ public:
         {
             if (m_CBT) cbt_Release(m_CBT);
             m_CBT = cbt_CreateAtDepth(m_UI.CBTMaxDepth, s_CBTInitDepth);
+            m_NeighbourTableValid = false;
             CreateCBTBuffer();
             if (m_UI.Backend != Backend_CPU) CopyToCBTBuffer();
             CreateCBTBindingSets();
@@ -647,6 +608,7 @@ public:
         else if (m_UI.CBTFlags.test(CBT_Bit_Reset))
         {
             cbt_ResetToDepth(m_CBT, s_CBTInitDepth);
+            m_NeighbourTableValid = false;
             if (m_UI.Backend != Backend_CPU) CopyToCBTBuffer();
         }
         m_UI.CBTFlags.reset();
@@ -697,6 +659,13 @@ protected:
 
         ImGui::Separator();
 
+        if (m_UI.Backend == Backend_CPU)
+        {
+            ImGui::Checkbox("Neighbour Table", &m_UI.UseNeighbourTable);
+            if (m_UI.UseNeighbourTable)
+                ImGui::LabelText("Neighbour Table Memory", "%.1f KiB", static_cast<float>(m_UI.NeighbourTableByteSize) / 1024.0f);
+        }
+
         if (m_UI.Backend == Backend_GPU)
         {
             ImGui::LabelText("Subdivision (GPU)", "%.3f ms", m_UI.TimerData[Timer_Subdivision]);
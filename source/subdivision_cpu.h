@@ -0,0 +1,122 @@
+#pragma once
+
+// Methods for performing CBT split / merge logic on the CPU
+// Kept free of Donut so that cbt_bench can measure exactly what the CPU backend runs.
+// As with leb.h, cbt.h and leb.h must be included before this header.
+
+#include "leb_neighbour_table.h"
+
+inline float Wedge(const float* a, const float* b)
+{
+    return a[0] * b[1] - a[1] * b[0];
+}
+
+inline bool IsInside(const float faceVertices[][3], const float target[2])
+{
+    float v1[2] = { faceVertices[0][0], faceVertices[1][0] };
+    float v2[2] = { faceVertices[0][1], faceVertices[1][1] };
+    float v3[2] = { faceVertices[0][2], faceVertices[1][2] };
+    float x1[2] = { v2[0] - v1[0], v2[1] - v1[1] };
+    float x2[2] = { v3[0] - v2[0], v3[1] - v2[1] };
+    float x3[2] = { v1[0] - v3[0], v1[1] - v3[1] };
+    float y1[2] = { target[0] - v1[0], target[1] - v1[1] };
+    float y2[2] = { target[0] - v2[0], target[1] - v2[1] };
+    float y3[2] = { target[0] - v3[0], target[1] - v3[1] };
+    float w1 = Wedge(x1, y1);
+    float w2 = Wedge(x2, y2);
+    float w3 = Wedge(x3, y3);
+
+    return (w1 >= 0.0f) && (w2 >= 0.0f) && (w3 >= 0.0f);
+}
+
+inline bool IsInside(const cbt_Node node, const float target[2])
+{
+    float faceVertices[][3] = {
+        {0.0f, 0.0f, 1.0f},
+        {1.0f, 0.0f, 0.0f}
+    };
+
+    leb_DecodeNodeAttributeArray_Square(node, 2, faceVertices);
+
+    return IsInside(faceVertices, target);
+}
+
+// userData points to the target position (two floats)
+inline void UpdateSubdivisionCpuCallback_Split(
+    cbt_Tree* cbt,
+    const cbt_Node node,
+    const void* userData
+) {
+    const float* target = static_cast<const float*>(userData);
+
+    float faceVertices[][3] = {
+        {0.0f, 0.0f, 1.0f},
+        {1.0f, 0.0f, 0.0f}
+    };
+
+    leb_DecodeNodeAttributeArray_Square(node, 2, faceVertices);
+
+    if (IsInside(faceVertices, target)) {
+        leb_SplitNode_Square(cbt, node);
+    }
+}
+
+inline void UpdateSubdivisionCpuCallback_Merge(
+    cbt_Tree* cbt,
+    const cbt_Node node,
+    const void* userData
+) {
+    const float* target = static_cast<const float*>(userData);
+
+    float baseFaceVertices[][3] = {
+        {0.0f, 0.0f, 1.0f},
+        {1.0f, 0.0f, 0.0f}
+    };
+    float topFaceVertices[][3] = {
+        {0.0f, 0.0f, 1.0f},
+        {1.0f, 0.0f, 0.0f}
+    };
+
+    leb_DiamondParent diamondParent = leb_DecodeDiamondParent_Square(node);
+
+    leb_DecodeNodeAttributeArray_Square(diamondParent.base, 2, baseFaceVertices);
+    leb_DecodeNodeAttributeArray_Square(diamondParent.top, 2, topFaceVertices);
+
+    if (!IsInside(baseFaceVertices, target) && !IsInside(topFaceVertices, target)) {
+        leb_MergeNode_Square(cbt, node, diamondParent);
+    }
+}
+
+// Same as above, but splits and merges go through a neighbour table (see leb_neighbour_table.h)
+struct SubdivisionCpuTableData
+{
+    const float* Target;
+    LebNeighbourTable* Table;
+};
+
+// userData points to a SubdivisionCpuTableData
+inline void UpdateSubdivisionCpuTableCallback_Split(
+    cbt_Tree* cbt,
+    const cbt_Node node,
+    const void* userData
+) {
+    const SubdivisionCpuTableData* data = static_cast<const SubdivisionCpuTableData*>(userData);
+
+    if (IsInside(node, data->Target)) {
+        data->Table->SplitNode(cbt, node);
+    }
+}
+
+inline void UpdateSubdivisionCpuTableCallback_Merge(
+    cbt_Tree* cbt,
+    const cbt_Node node,
+    const void* userData
+) {
+    const SubdivisionCpuTableData* data = static_cast<const SubdivisionCpuTableData*>(userData);
+
+    leb_DiamondParent diamondParent = data->Table->DecodeDiamondParent(node);
+
+    if (!IsInside(diamondParent.base, data->Target) && !IsInside(diamondParent.top, data->Target)) {
+        data->Table->MergeNode(cbt, node, diamondParent);
+    }
+}